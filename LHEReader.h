@@ -0,0 +1,77 @@
+//**************************************************************************************************************
+//	Filename:		LHEReader.h
+//	Reviser:		Victoria Trenton
+//
+// This is a header file for LHEReader.C. LHEReader reads MadGraph's Les Houches event files
+// (unweighted_events.lhe) directly, without first converting them to an LHEF ROOT file. It fills
+// the same leaf variables as ReadLHE, so ReadLHE::Loop runs on it unchanged. Its particle buffers
+// grow to fit the largest event read.
+//
+// Plain .lhe files are memory-mapped. Files ending in .gz (e.g. unweighted_events.lhe.gz or
+// unweighted_events.lhe.tar.gz) are decompressed as a stream, so a run can be read straight
+// from its tarball. Only <event> blocks are parsed; everything between them (the <init> block,
+// tar headers) is skipped.
+//**************************************************************************************************************
+
+#ifndef LHEReader_h
+#define LHEReader_h
+
+// (ReadLHE.h implements ReadLHE outside its include guard when ReadLHE_cxx is defined, so only
+// include it if ReadLHE.C hasn't already)
+#ifndef ReadLHE_h
+#include "ReadLHE.h"
+#endif
+
+#include <zlib.h>
+#include <string>
+#include <vector>
+
+class LHEReader : public ReadLHE
+{
+	public :
+	LHEReader(const char *pattern);		// File path, or wildcard matching several files
+	LHEReader(const std::vector<std::string>& files);	// Files, in order, taken literally
+
+	virtual ~LHEReader();
+	virtual Int_t    GetEntry(Long64_t entry);
+	virtual Long64_t LoadTree(Long64_t entry);
+	virtual Long64_t GetEntriesFast();
+	virtual void     Show(Long64_t entry = -1);
+	virtual void     FillHistogramsBulk (LHEHistogramSets& histos, Long64_t first, Long64_t last);
+	virtual void     FillHistogramsParallel (LHEHistogramSets& histos, Int_t nThreads, Bool_t bulkRead);
+	virtual Int_t    GetNInputFiles() { return fFiles.size(); }
+	virtual TString  GetInputFileName (Int_t i) { return fFiles[i].c_str(); }
+	virtual ReadLHE* OpenInputFile (Int_t i);
+
+	Int_t            GetNfiles() const { return fFiles.size(); }
+
+	private :
+	void             InitReader();
+	Bool_t           OpenFile(Int_t index);
+	void             CloseFile();
+	Bool_t           FillBuffer();
+	Bool_t           NextEvent();
+	void             Rewind();
+
+	std::vector<std::string> fFiles;		// Input files, in order
+	Int_t            fFileIndex;			// Index of the open file (-1 if none)
+
+	int              fFd;					// Plain file: descriptor and memory map
+	char            *fMap;
+	size_t           fMapSize;
+
+	gzFile           fGz;					// Gzip file: stream and decompression buffer
+	std::vector<char> fBuffer;
+	Bool_t           fGzEOF;
+
+	const char      *fData;				// Readable text of the open file (map or buffer)
+	size_t           fDataSize;
+	size_t           fPos;					// Where to search for the next <event>
+
+	const char      *fEventBegin;			// Body of the current <event> block
+	const char      *fEventEnd;
+	Long64_t         fEntry;				// Entry number of the current event (-1 if none)
+	Long64_t         fParsedEntry;			// Entry whose leaf variables are filled
+};
+
+#endif
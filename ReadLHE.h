@@ -2,8 +2,9 @@
 //	Filename:		ReadLHE.h
 //	Reviser:		Victoria Trenton
 // 
-// This is a header file for ReadLHE.C. Before running ReadLHE.C, the user should change
-// kMaxParticle to the appropriate value.
+// This is a header file for ReadLHE.C. BasicReadLHE is templated on the model's particle capacity
+// (the largest Particle_size over all events): use ReadLHE_QBall or ReadLHE_Leptosusy for those
+// models, or ReadLHE, which sizes its particle buffers from the input files.
 //
 // This class has been automatically generated on
 // Wed Jul  6 15:37:46 2011 by ROOT version 5.26/00
@@ -17,20 +18,285 @@
 #include <TROOT.h>
 #include <TChain.h>
 #include <TFile.h>
+#include <TError.h>
+#include <TH1.h>
+#include <TH2.h>
+#include <TLeaf.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstring>
 
-// Stop printing of error messages. Used to suppress the warning "No dictionary for class"
-gErrorIgnoreLevel = kError;
-
-// Note: kMaxParticle is the maximum value of Particle_size (total number of particles produced)
-// over all events
 const Int_t kMaxEvent = 1;
-const Int_t kMaxParticle = 22;		// For QBalls: 4, Leptosusy: 22
+const Double_t kEtaCut = 2.2;		// h_eta_cut is filled for |eta| < kEtaCut
+
+// Seconds on a monotonic clock, for timing the phases of filling histograms
+inline Double_t LHEClock()
+{
+	return std::chrono::duration<Double_t> (std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Maximum value of Particle_size (total number of particles produced) over all events of each
+// model. kDynamicParticles sizes the buffers from the input instead (see BasicReadLHE::Notify).
+const Int_t kDynamicParticles = 0;
+const Int_t kQBallParticles = 4;
+const Int_t kLeptosusyParticles = 22;
+
+// Buffer for one Particle.* leaf. With a capacity N > 0 it is a fixed array, so loops over it have
+// a known maximum trip count. With N = 0 (kDynamicParticles) it is a vector that Reserve grows.
+template <typename T, Int_t N>
+class ParticleLeaf
+{
+	public :
+	T*       GetArray()                 { return fData; }
+	Int_t    GetCapacity() const        { return N; }
+	Bool_t   Reserve (Int_t n)          { return n <= N; }		// False if n particles don't fit
+	T&       operator[] (Int_t i)       { return fData[i]; }
+	const T& operator[] (Int_t i) const { return fData[i]; }
+	
+	private :
+	T        fData[N];
+};
+
+template <typename T>
+class ParticleLeaf<T, kDynamicParticles>
+{
+	public :
+	ParticleLeaf() : fData (1) {}		// Never empty, so GetArray is always a valid branch address
+	T*       GetArray()                 { return &fData[0]; }
+	Int_t    GetCapacity() const        { return fData.size(); }
+	Bool_t   Reserve (Int_t n)          { if (n > (Int_t) fData.size()) fData.resize (n); return kTRUE; }
+	T&       operator[] (Int_t i)       { return fData[i]; }
+	const T& operator[] (Int_t i) const { return fData[i]; }
+	
+	private :
+	std::vector<T> fData;
+};
+
+// Fixed-width 1D histogram that counts fills before they are added to a TH1 in one go (FlushTo).
+// The bin is found with one multiply by the reciprocal bin width, counts are kept as floats, and
+// only the statistics TH1::Fill keeps (sum of x and x^2 over in-range fills) are accumulated.
+// Bins are numbered as in ROOT: 0 is underflow and nbins+1 is overflow.
+class FastHist1D
+{
+	public :
+	FastHist1D();
+	void         SetBinning (Int_t nbins, Double_t xmin, Double_t xmax);
+	void         SetBinning (const TAxis* axis);
+	inline Int_t FindBin (Double_t x) const;
+	inline void  Fill (Double_t x);
+	void         FlushTo (TH1* h);
+	Double_t     GetEntries() const { return fEntries; }
+	
+	private :
+	Int_t                 fNbins;
+	Double_t              fXmin, fXmax, fInvWidth;
+	std::vector<Float_t>  fCounts;
+	Double_t              fEntries, fSumw, fSumwx, fSumwx2;
+};
+
+// Fixed-width 2D version of FastHist1D. Cells are numbered as ROOT's global bins,
+// binx + (nbinsx+2) * biny, so they can be copied into a TH2 directly.
+class FastHist2D
+{
+	public :
+	FastHist2D();
+	void         SetBinning (const TAxis* xaxis, const TAxis* yaxis);
+	inline void  Fill (Double_t x, Double_t y);
+	void         FlushTo (TH1* h);
+	
+	private :
+	FastHist1D            fX, fY;				// Used for their binning only
+	Int_t                 fNbinsX, fNbinsY;
+	std::vector<Float_t>  fCounts;
+	Double_t              fEntries, fSumw, fSumwx, fSumwx2, fSumwy, fSumwy2, fSumwxy;
+};
+
+inline Int_t FastHist1D::FindBin (Double_t x) const
+{
+	if (x < fXmin) return 0;
+	if (!(x < fXmax)) return fNbins + 1;		// Also NaN, like TAxis::FindFixBin
+	Int_t bin = 1 + (Int_t) ((x - fXmin) * fInvWidth);
+	return bin > fNbins ? fNbins : bin;
+}
+
+inline void FastHist1D::Fill (Double_t x)
+{
+	Int_t bin = FindBin (x);
+	fCounts[bin] += 1;
+	fEntries++;
+	if (bin > 0 && bin <= fNbins)
+	{
+		fSumw++;
+		fSumwx += x;
+		fSumwx2 += x * x;
+	}
+}
+
+inline void FastHist2D::Fill (Double_t x, Double_t y)
+{
+	Int_t binx = fX.FindBin (x);
+	Int_t biny = fY.FindBin (y);
+	fCounts[binx + (fNbinsX + 2) * biny] += 1;
+	fEntries++;
+	if (binx > 0 && binx <= fNbinsX && biny > 0 && biny <= fNbinsY)
+	{
+		fSumw++;
+		fSumwx += x;
+		fSumwx2 += x * x;
+		fSumwy += y;
+		fSumwy2 += y * y;
+		fSumwxy += x * y;
+	}
+}
+
+// Set of histograms filled by ReadLHE::Loop for one particle species. Each worker thread of a
+// parallel loop fills its own set, and the sets are merged at the end.
+// Fill only gathers a particle's leaf data; once kBlockSize particles are gathered, their
+// kinematics are computed together and binned in FastHist counters. Flush must be called before
+// the TH1F/TH2F histograms are used. FillPerParticle is the original one-particle-at-a-time path.
+// The time spent computing kinematics and binning is kept, and is summed by Add.
+struct LHEHistograms
+{
+	TH1F* h_eta;
+	TH1F* h_eta_cut;
+	TH1F* h_E;
+	TH1F* h_Ek;
+	TH1F* h_ET;
+	TH1F* h_pt;
+	TH1F* h_gamma;
+	TH1F* h_beta;
+	TH2F* h_ek_eta;
+
+	LHEHistograms (const char* suffix = "");
+	~LHEHistograms();
+	inline void Fill (Double_t eta, Double_t pt, Double_t E, Double_t M);
+	void  FillPerParticle (Double_t eta, Double_t pt, Double_t E, Double_t M);
+	void  Flush();
+	void  Reset();
+	void  Add (const LHEHistograms& other);
+	Bool_t AddFrom (TDirectory* dir);
+	Int_t Compare (const LHEHistograms& other) const;
+	void  Write() const;
+	Bool_t WriteTo (TDirectory* dir) const;
+	TString GetBinningKey() const;
+	Double_t GetKinematicsTime() const { return fKinematicsTime; }
+	Double_t GetFillTime() const { return fFillTime; }
+
+	private :
+	enum { kBlockSize = 1024, kNHistograms = 9 };
+	void  FillBlock();
+	void  FlushFast();
+	void  GetHistograms (TH1* hists[kNHistograms]) const;
+
+	// Gathered leaf data (struct of arrays) and the kinematics computed from it
+	Int_t    fNGathered;
+	Double_t fEta[kBlockSize], fPT[kBlockSize], fE[kBlockSize], fM[kBlockSize];
+	Double_t fEK[kBlockSize], fET[kBlockSize], fGamma[kBlockSize], fBeta[kBlockSize];
+
+	FastHist1D f_eta, f_eta_cut, f_E, f_Ek, f_ET, f_pt, f_gamma, f_beta;
+	FastHist2D f_ek_eta;
+	
+	Double_t fKinematicsTime, fFillTime;	// Seconds computing kinematics, and binning them
+};
+
+inline void LHEHistograms::Fill (Double_t eta, Double_t pt, Double_t E, Double_t M)
+{
+	fEta[fNGathered] = eta;
+	fPT[fNGathered] = pt;
+	fE[fNGathered] = E;
+	fM[fNGathered] = M;
+	if (++fNGathered == kBlockSize)
+		FillBlock();
+}
+
+// One set of histograms per selected particle species
+typedef std::vector<LHEHistograms*> LHEHistogramSets;
+
+// Lookup from a particle's PID (particle or antiparticle) to the histogram set it fills
+// (species, or -1 if not selected) and the mass it is corrected to (mass, or 0 if none).
+// PIDs below kDenseSize (quarks, leptons) are looked up directly; larger ones (e.g. QBalls,
+// 100XXXY0) are kept in a short sorted list.
+class PIDTable
+{
+	public :
+	struct Entry
+	{
+		Int_t    species;
+		Double_t mass;
+	};
+	
+	PIDTable();
+	void         SetSpecies (Int_t pid, Int_t species);
+	void         SetMass (Int_t pid, Double_t mass);
+	const Entry& Find (Int_t pid) const;
+	TString      GetKey() const;
+	
+	private :
+	enum { kDenseSize = 64 };
+	Entry&       Insert (Int_t pid);
+	
+	Entry                 fDense[kDenseSize];
+	std::vector<Int_t>    fSparsePID;		// Sorted
+	std::vector<Entry>    fSparseEntry;
+	Entry                 fNone;
+};
+
+inline const PIDTable::Entry& PIDTable::Find (Int_t pid) const
+{
+	Int_t apid = pid < 0 ? -pid : pid;
+	if (apid < kDenseSize)
+		return fDense[apid];
+	
+	// Binary search of the sparse list
+	size_t lo = 0, hi = fSparsePID.size();
+	while (lo < hi)
+	{
+		size_t mid = (lo + hi) / 2;
+		if (fSparsePID[mid] < apid)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return (lo < fSparsePID.size() && fSparsePID[lo] == apid) ? fSparseEntry[lo] : fNone;
+}
+
+// A batch of events read column by column for ReadLHE::FillHistogramsBulk. The particles of all
+// events are stored back to back in one array per branch (struct of arrays), and event i's
+// particles are at indices [offset[i], offset[i+1]).
+struct LHEEventBatch
+{
+	Int_t                 nEvents;
+	std::vector<Int_t>    offset;
+	std::vector<Int_t>    PID;
+	std::vector<Int_t>    Status;
+	std::vector<Double_t> Eta;
+	std::vector<Double_t> PT;
+	std::vector<Double_t> E;
+	std::vector<Double_t> M;
+};
+
+// A range of entries of one input file, for one worker of BasicReadLHE::FillHistogramsPool
+struct LHEWorkUnit
+{
+	Int_t    file;						// Input file number (see BasicReadLHE::GetInputFileName)
+	Long64_t first, last;				// Entry range local to the file (last < 0: to its end)
+	TString  cacheKey;					// For a whole file: cache its histograms under this key
+};
 
-class ReadLHE
+template <Int_t kMaxParticle>
+class BasicReadLHE
 {
 	public :
 	TTree          *fChain;   //!pointer to the analyzed TTree or TChain
 	Int_t           fCurrent; //!current Tree number in a TChain
+	Long64_t        fNEvents; //!number of events read by the last MakeHistograms
+	Long64_t        fNBytes;  //!number of bytes read by the last MakeHistograms
+	Double_t        fReadTime; //!seconds reading entries in the last MakeHistograms (summed over threads)
+	Long64_t        fNUnread; //!entries skipped or unreadable in the last MakeHistograms (an unreadable file counts as one)
+	PIDTable        fPIDTable; //!selected PIDs and mass corrections (see BuildPIDTable)
+	Bool_t          fSkipTree; //!current tree has more particles per event than kMaxParticle
+	std::string     fCacheDir; //!directory of the per-file histogram cache (empty: no cache)
 
 	// Declaration of leaf types
 	Int_t           Event_;
@@ -45,25 +311,25 @@ class ReadLHE
 	Double_t        Event_CouplingQCD[kMaxEvent];   //[Event_]
 	Int_t           Event_size;
 	Int_t           Particle_;
-	UInt_t          Particle_fUniqueID[kMaxParticle];   //[Particle_]
-	UInt_t          Particle_fBits[kMaxParticle];   //[Particle_]
-	Int_t           Particle_PID[kMaxParticle];   //[Particle_]
-	Int_t           Particle_Status[kMaxParticle];   //[Particle_]
-	Int_t           Particle_Mother1[kMaxParticle];   //[Particle_]
-	Int_t           Particle_Mother2[kMaxParticle];   //[Particle_]
-	Int_t           Particle_ColorLine1[kMaxParticle];   //[Particle_]
-	Int_t           Particle_ColorLine2[kMaxParticle];   //[Particle_]
-	Double_t        Particle_Px[kMaxParticle];   //[Particle_]
-	Double_t        Particle_Py[kMaxParticle];   //[Particle_]
-	Double_t        Particle_Pz[kMaxParticle];   //[Particle_]
-	Double_t        Particle_E[kMaxParticle];   //[Particle_]
-	Double_t        Particle_M[kMaxParticle];   //[Particle_]
-	Double_t        Particle_PT[kMaxParticle];   //[Particle_]
-	Double_t        Particle_Eta[kMaxParticle];   //[Particle_]
-	Double_t        Particle_Phi[kMaxParticle];   //[Particle_]
-	Double_t        Particle_Rapidity[kMaxParticle];   //[Particle_]
-	Double_t        Particle_LifeTime[kMaxParticle];   //[Particle_]
-	Double_t        Particle_Spin[kMaxParticle];   //[Particle_]
+	ParticleLeaf<UInt_t, kMaxParticle>   Particle_fUniqueID;   //[Particle_]
+	ParticleLeaf<UInt_t, kMaxParticle>   Particle_fBits;   //[Particle_]
+	ParticleLeaf<Int_t, kMaxParticle>    Particle_PID;   //[Particle_]
+	ParticleLeaf<Int_t, kMaxParticle>    Particle_Status;   //[Particle_]
+	ParticleLeaf<Int_t, kMaxParticle>    Particle_Mother1;   //[Particle_]
+	ParticleLeaf<Int_t, kMaxParticle>    Particle_Mother2;   //[Particle_]
+	ParticleLeaf<Int_t, kMaxParticle>    Particle_ColorLine1;   //[Particle_]
+	ParticleLeaf<Int_t, kMaxParticle>    Particle_ColorLine2;   //[Particle_]
+	ParticleLeaf<Double_t, kMaxParticle> Particle_Px;   //[Particle_]
+	ParticleLeaf<Double_t, kMaxParticle> Particle_Py;   //[Particle_]
+	ParticleLeaf<Double_t, kMaxParticle> Particle_Pz;   //[Particle_]
+	ParticleLeaf<Double_t, kMaxParticle> Particle_E;   //[Particle_]
+	ParticleLeaf<Double_t, kMaxParticle> Particle_M;   //[Particle_]
+	ParticleLeaf<Double_t, kMaxParticle> Particle_PT;   //[Particle_]
+	ParticleLeaf<Double_t, kMaxParticle> Particle_Eta;   //[Particle_]
+	ParticleLeaf<Double_t, kMaxParticle> Particle_Phi;   //[Particle_]
+	ParticleLeaf<Double_t, kMaxParticle> Particle_Rapidity;   //[Particle_]
+	ParticleLeaf<Double_t, kMaxParticle> Particle_LifeTime;   //[Particle_]
+	ParticleLeaf<Double_t, kMaxParticle> Particle_Spin;   //[Particle_]
 	Int_t           Particle_size;
 	
 	// List of branches
@@ -100,23 +366,93 @@ class ReadLHE
 	TBranch        *b_Particle_Spin;   //!
 	TBranch        *b_Particle_size;   //!
 	
-	ReadLHE(TTree *tree=0);
+	BasicReadLHE(TTree *tree=0);
 	
-	virtual ~ReadLHE();
+	protected :
+	// Used by subclasses that fill the leaf variables from another source (see LHEReader.h)
+	enum EInput { kNoTree };
+	BasicReadLHE(EInput);
+	
+	public :
+	
+	virtual ~BasicReadLHE();
 	virtual Int_t    Cut(Long64_t entry);
 	virtual Int_t    GetEntry(Long64_t entry);
 	virtual Long64_t LoadTree(Long64_t entry);
+	virtual Long64_t GetEntriesFast();
 	virtual void     Init(TTree *tree);
-	virtual void     Loop (float charge);
+	virtual void     Loop (float charge, Int_t nThreads = 1, Bool_t bulkRead = kFALSE);
+	virtual void     Loop (const std::vector<float>& charges, Int_t nThreads = 1, Bool_t bulkRead = kFALSE);
+	virtual void     MakeHistograms (float charge, LHEHistograms& histos, Int_t nThreads = 1,
+								 Bool_t bulkRead = kFALSE);
+	virtual void     MakeHistograms (const std::vector<Int_t>& pids, LHEHistogramSets& histos,
+								 Int_t nThreads = 1, Bool_t bulkRead = kFALSE);
+	virtual void     FillHistograms (LHEHistogramSets& histos, Long64_t first, Long64_t last);
+	virtual void     FillHistogramsBulk (LHEHistogramSets& histos, Long64_t first, Long64_t last);
+	virtual void     FillHistogramsParallel (LHEHistogramSets& histos, Int_t nThreads, Bool_t bulkRead);
+	virtual void     FillHistogramsCached (LHEHistogramSets& histos, Int_t nThreads, Bool_t bulkRead);
+	virtual void     FillEvent (LHEHistogramSets& histos);
+	virtual void     FillBatch (LHEHistogramSets& histos, LHEEventBatch& batch);
+	void             BuildPIDTable (const std::vector<Int_t>& pids);
+	void             SetCacheDir (const char* dir) { fCacheDir = dir ? dir : ""; }
+	virtual Int_t    GetNInputFiles();
+	virtual TString  GetInputFileName (Int_t i);
+	virtual BasicReadLHE* OpenInputFile (Int_t i);
+	static Int_t     ChargeToPID (float charge);
+	static Int_t     GetMaxParticles (TTree* tree);
+	Bool_t           ReserveParticles (Int_t n);
 	virtual Bool_t   Notify();
 	virtual void     Show(Long64_t entry = -1);
+	
+	protected :
+	void             FillHistogramsPool (LHEHistogramSets& histos, const std::vector<LHEWorkUnit>& units,
+									 Int_t nThreads, Bool_t bulkRead);
+	
+	private :
+	void             SetParticleAddresses();
+	inline void      FillParticle (LHEHistogramSets& histos, Int_t ip);
+	TString          GetCacheKey (const char* fileName, const LHEHistogramSets& histos);
+	TString          GetCachePath (const TString& key);
+	Bool_t           ReadCache (const TString& key, LHEHistogramSets& histos);
+	void             WriteCache (const TString& key, const LHEHistogramSets& histos, Long64_t nEvents);
 };
 
+// Models with a fixed capacity, and the default, which fits its buffers to the input
+typedef BasicReadLHE<kDynamicParticles>   ReadLHE;
+typedef BasicReadLHE<kQBallParticles>     ReadLHE_QBall;
+typedef BasicReadLHE<kLeptosusyParticles> ReadLHE_Leptosusy;
+
 #endif
 
 #ifdef ReadLHE_cxx
-ReadLHE::ReadLHE(TTree *tree)
+// ROOT's error handler, to which LHEErrorHandler passes on every other message
+static ErrorHandlerFunc_t gLHEPreviousErrorHandler = 0;
+
+//=====================================================================
+// Drop the warning "no dictionary for class" (the LHEF files store ExRootAnalysis classes that
+// are not loaded here) and leave every other message to ROOT
+//=====================================================================
+static void LHEErrorHandler(Int_t level, Bool_t abort, const char *location, const char *msg)
+{
+	if (level < kError && msg && strstr(msg, "dictionary for class")) return;
+	
+	if (gLHEPreviousErrorHandler) gLHEPreviousErrorHandler(level, abort, location, msg);
+	else DefaultErrorHandler(level, abort, location, msg);
+}
+
+// Install LHEErrorHandler once, even when readers are constructed in several threads
+static void InstallLHEErrorHandler()
+{
+	static const Bool_t installed = (gLHEPreviousErrorHandler = SetErrorHandler(LHEErrorHandler), kTRUE);
+	(void) installed;
+}
+
+template <Int_t kMaxParticle>
+BasicReadLHE<kMaxParticle>::BasicReadLHE(TTree *tree)
 {
+	// Stop printing of the warning "No dictionary for class" (but not of other messages)
+	InstallLHEErrorHandler();
+	
 	// if parameter tree is not specified (or zero), connect the file
 	// used to generate this class and read the Tree.
 	if (tree == 0)
@@ -148,20 +484,52 @@ ReadLHE::ReadLHE(TTree *tree)
 	Init(tree);
 }
 
-ReadLHE::~ReadLHE()
+template <Int_t kMaxParticle>
+BasicReadLHE<kMaxParticle>::BasicReadLHE(EInput)
+{
+	InstallLHEErrorHandler();
+	
+	// Leave fChain unset; the subclass reads events through LoadTree and GetEntry
+	fChain = 0;
+	fCurrent = -1;
+	fNEvents = 0;
+	fNBytes = 0;
+	fReadTime = 0;
+	fNUnread = 0;
+	fSkipTree = kFALSE;
+}
+
+template <Int_t kMaxParticle>
+BasicReadLHE<kMaxParticle>::~BasicReadLHE()
 {
 	if (!fChain) return;
+	
+	// A chain owns its current file and closes it when the chain is deleted
+	if (fChain->InheritsFrom(TChain::Class())) return;
 	delete fChain->GetCurrentFile();
 }
 
-Int_t ReadLHE::GetEntry(Long64_t entry)
+template <Int_t kMaxParticle>
+Int_t BasicReadLHE<kMaxParticle>::GetEntry(Long64_t entry)
 {
-	// Read contents of entry.
+	// Read contents of entry. Its tree is loaded first, so that Notify has sized the particle
+	// buffers for it; nothing is read from a tree that would overrun them.
 	if (!fChain) return 0;
-	return fChain->GetEntry(entry);
+	Long64_t centry = LoadTree(entry);
+	if (centry < 0 || fSkipTree) return 0;
+	return fChain->GetTree()->GetEntry(centry);
 }
 
-Long64_t ReadLHE::LoadTree(Long64_t entry)
+template <Int_t kMaxParticle>
+Long64_t BasicReadLHE<kMaxParticle>::GetEntriesFast()
+{
+	// Number of entries to loop over (an upper bound for a chain whose files are not yet open)
+	if (!fChain) return 0;
+	return fChain->GetEntriesFast();
+}
+
+template <Int_t kMaxParticle>
+Long64_t BasicReadLHE<kMaxParticle>::LoadTree(Long64_t entry)
 {
 	// Set the environment to read one entry
 	if (!fChain) return -5;
@@ -179,7 +547,8 @@ Long64_t ReadLHE::LoadTree(Long64_t entry)
 	return centry;
 }
 
-void ReadLHE::Init(TTree *tree)
+template <Int_t kMaxParticle>
+void BasicReadLHE<kMaxParticle>::Init(TTree *tree)
 {
 	// The Init() function is called when the selector needs to initialize
 	// a new tree or chain. Typically here the branch addresses and branch
@@ -193,6 +562,11 @@ void ReadLHE::Init(TTree *tree)
 	if (!tree) return;
 	fChain = tree;
 	fCurrent = -1;
+	fNEvents = 0;
+	fNBytes = 0;
+	fReadTime = 0;
+	fNUnread = 0;
+	fSkipTree = kFALSE;
 	fChain->SetMakeClass(1);
 		
 	fChain->SetBranchAddress("Event", &Event_, &b_Event_);
@@ -207,31 +581,41 @@ void ReadLHE::Init(TTree *tree)
 	fChain->SetBranchAddress("Event.CouplingQCD", Event_CouplingQCD, &b_Event_CouplingQCD);
 	fChain->SetBranchAddress("Event_size", &Event_size, &b_Event_size);
 	fChain->SetBranchAddress("Particle", &Particle_, &b_Particle_);
-	fChain->SetBranchAddress("Particle.fUniqueID", Particle_fUniqueID, &b_Particle_fUniqueID);
-	fChain->SetBranchAddress("Particle.fBits", Particle_fBits, &b_Particle_fBits);
-	fChain->SetBranchAddress("Particle.PID", Particle_PID, &b_Particle_PID);
-	fChain->SetBranchAddress("Particle.Status", Particle_Status, &b_Particle_Status);
-	fChain->SetBranchAddress("Particle.Mother1", Particle_Mother1, &b_Particle_Mother1);
-	fChain->SetBranchAddress("Particle.Mother2", Particle_Mother2, &b_Particle_Mother2);
-	fChain->SetBranchAddress("Particle.ColorLine1", Particle_ColorLine1, &b_Particle_ColorLine1);
-	fChain->SetBranchAddress("Particle.ColorLine2", Particle_ColorLine2, &b_Particle_ColorLine2);
-	fChain->SetBranchAddress("Particle.Px", Particle_Px, &b_Particle_Px);
-	fChain->SetBranchAddress("Particle.Py", Particle_Py, &b_Particle_Py);
-	fChain->SetBranchAddress("Particle.Pz", Particle_Pz, &b_Particle_Pz);
-	fChain->SetBranchAddress("Particle.E", Particle_E, &b_Particle_E);
-	fChain->SetBranchAddress("Particle.M", Particle_M, &b_Particle_M);
-	fChain->SetBranchAddress("Particle.PT", Particle_PT, &b_Particle_PT);
-	fChain->SetBranchAddress("Particle.Eta", Particle_Eta, &b_Particle_Eta);
-	fChain->SetBranchAddress("Particle.Phi", Particle_Phi, &b_Particle_Phi);
-	fChain->SetBranchAddress("Particle.Rapidity", Particle_Rapidity, &b_Particle_Rapidity);
-	fChain->SetBranchAddress("Particle.LifeTime", Particle_LifeTime, &b_Particle_LifeTime);
-	fChain->SetBranchAddress("Particle.Spin", Particle_Spin, &b_Particle_Spin);
 	fChain->SetBranchAddress("Particle_size", &Particle_size, &b_Particle_size);
+	SetParticleAddresses();
 	
 	Notify();
 }
 
-Bool_t ReadLHE::Notify()
+template <Int_t kMaxParticle>
+void BasicReadLHE<kMaxParticle>::SetParticleAddresses()
+{
+	// Point the Particle.* branches at the particle buffers (again after ReserveParticles moves them)
+	if (!fChain) return;
+	
+	fChain->SetBranchAddress("Particle.fUniqueID", Particle_fUniqueID.GetArray(), &b_Particle_fUniqueID);
+	fChain->SetBranchAddress("Particle.fBits", Particle_fBits.GetArray(), &b_Particle_fBits);
+	fChain->SetBranchAddress("Particle.PID", Particle_PID.GetArray(), &b_Particle_PID);
+	fChain->SetBranchAddress("Particle.Status", Particle_Status.GetArray(), &b_Particle_Status);
+	fChain->SetBranchAddress("Particle.Mother1", Particle_Mother1.GetArray(), &b_Particle_Mother1);
+	fChain->SetBranchAddress("Particle.Mother2", Particle_Mother2.GetArray(), &b_Particle_Mother2);
+	fChain->SetBranchAddress("Particle.ColorLine1", Particle_ColorLine1.GetArray(), &b_Particle_ColorLine1);
+	fChain->SetBranchAddress("Particle.ColorLine2", Particle_ColorLine2.GetArray(), &b_Particle_ColorLine2);
+	fChain->SetBranchAddress("Particle.Px", Particle_Px.GetArray(), &b_Particle_Px);
+	fChain->SetBranchAddress("Particle.Py", Particle_Py.GetArray(), &b_Particle_Py);
+	fChain->SetBranchAddress("Particle.Pz", Particle_Pz.GetArray(), &b_Particle_Pz);
+	fChain->SetBranchAddress("Particle.E", Particle_E.GetArray(), &b_Particle_E);
+	fChain->SetBranchAddress("Particle.M", Particle_M.GetArray(), &b_Particle_M);
+	fChain->SetBranchAddress("Particle.PT", Particle_PT.GetArray(), &b_Particle_PT);
+	fChain->SetBranchAddress("Particle.Eta", Particle_Eta.GetArray(), &b_Particle_Eta);
+	fChain->SetBranchAddress("Particle.Phi", Particle_Phi.GetArray(), &b_Particle_Phi);
+	fChain->SetBranchAddress("Particle.Rapidity", Particle_Rapidity.GetArray(), &b_Particle_Rapidity);
+	fChain->SetBranchAddress("Particle.LifeTime", Particle_LifeTime.GetArray(), &b_Particle_LifeTime);
+	fChain->SetBranchAddress("Particle.Spin", Particle_Spin.GetArray(), &b_Particle_Spin);
+}
+
+template <Int_t kMaxParticle>
+Bool_t BasicReadLHE<kMaxParticle>::Notify()
 {
 	// The Notify() function is called when a new file is opened. This
 	// can be either for a new TTree in a TChain or when when a new TTree
@@ -239,18 +623,80 @@ Bool_t ReadLHE::Notify()
 	// to the generated code, but the routine can be extended by the
 	// user if needed. The return value is currently not used.
 	
+	// Make sure the particle buffers hold the largest event of the new tree. A fixed-capacity
+	// model can't grow them, so it skips a tree whose events don't fit rather than overrun them.
+	fSkipTree = kFALSE;
+	TTree *tree = fChain ? fChain->GetTree() : 0;
+	if (!tree) return kTRUE;
+	
+	Int_t maxParticles = GetMaxParticles(tree);
+	if (!ReserveParticles(maxParticles))
+	{
+		Error("Notify", "%s has events with %d particles, more than this model's %d; skipping it",
+			  tree->GetCurrentFile() ? tree->GetCurrentFile()->GetName() : tree->GetName(),
+			  maxParticles, kMaxParticle);
+		fSkipTree = kTRUE;
+	}
+	return kTRUE;
+}
+
+template <Int_t kMaxParticle>
+Int_t BasicReadLHE<kMaxParticle>::GetMaxParticles(TTree *tree)
+{
+	// Largest Particle_size over the tree's events. The Particle branch records the largest
+	// number of particles it was filled with, so normally no entries have to be read.
+	TLeaf *leaf = tree->GetLeaf("Particle_");
+	Int_t maximum = leaf ? leaf->GetMaximum() : 0;
+	if (maximum > 0) return maximum;
+	
+	// Otherwise scan the Particle_size branch
+	return (Int_t) tree->GetMaximum("Particle_size");
+}
+
+template <Int_t kMaxParticle>
+Bool_t BasicReadLHE<kMaxParticle>::ReserveParticles(Int_t n)
+{
+	// Make room for events of n particles. Returns false if a fixed-capacity model can't hold them.
+	if (n <= Particle_PID.GetCapacity()) return kTRUE;
+	if (kMaxParticle > 0) return kFALSE;
+	
+	Particle_fUniqueID.Reserve(n);
+	Particle_fBits.Reserve(n);
+	Particle_PID.Reserve(n);
+	Particle_Status.Reserve(n);
+	Particle_Mother1.Reserve(n);
+	Particle_Mother2.Reserve(n);
+	Particle_ColorLine1.Reserve(n);
+	Particle_ColorLine2.Reserve(n);
+	Particle_Px.Reserve(n);
+	Particle_Py.Reserve(n);
+	Particle_Pz.Reserve(n);
+	Particle_E.Reserve(n);
+	Particle_M.Reserve(n);
+	Particle_PT.Reserve(n);
+	Particle_Eta.Reserve(n);
+	Particle_Phi.Reserve(n);
+	Particle_Rapidity.Reserve(n);
+	Particle_LifeTime.Reserve(n);
+	Particle_Spin.Reserve(n);
+	SetParticleAddresses();
 	return kTRUE;
 }
 
-void ReadLHE::Show(Long64_t entry)
+template <Int_t kMaxParticle>
+void BasicReadLHE<kMaxParticle>::Show(Long64_t entry)
 {
 	// Print contents of entry.
 	// If entry is not specified, print current entry
+	// (Read through GetEntry first, so that nothing is shown from a tree it skips.)
 	if (!fChain) return;
+	if (entry < 0) entry = fChain->GetReadEntry();
+	if (GetEntry(entry) <= 0) return;
 	fChain->Show(entry);
 }
 
-Int_t ReadLHE::Cut(Long64_t entry)
+template <Int_t kMaxParticle>
+Int_t BasicReadLHE<kMaxParticle>::Cut(Long64_t entry)
 {
 	// This function may be called from Loop.
 	// returns  1 if entry is accepted.
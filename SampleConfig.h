@@ -0,0 +1,59 @@
+//**************************************************************************************************************
+//	Filename:		SampleConfig.h
+//	Reviser:		Victoria Trenton
+// 
+// This is a header file for SampleConfig.C. A SampleConfig holds the sample matrix (charges x mass
+// sets) read from a config file such as Samples.cfg, and builds each sample's name and input path.
+//
+// Config file format (one key per line, values separated by spaces, "#" starts a comment):
+//		charges		1										Charges as written in names (e.g. 0.3 1.0 2)
+//		masses		Ms1500_Mn600_Mg1200 Ms1000_Mn600_Mg2000	Mass strings as written in names
+//		input		/path/LSProd_%m/*.root					Input files (%c: charge, %m: mass)
+//		sample		Leptosusy_%m							Sample name (Results/<sample>_histos.root)
+//		threads		8										Optional: worker threads (default: all cores)
+//		bulkRead	1										Optional: read only the branches used
+//		massPlots	Leptosusy%c								Optional: mass comparison picture names
+//		chargePlots	Leptosusy_%m							Optional: charge comparison picture names
+//															(MakePlots.C: Plots/<type>_<name>.png)
+//		cache		Cache									Optional: directory of per-file histogram cache
+//		maxParticles 22									Optional: particles per event of the model
+//															(4: QBall, 22: Leptosusy, default: fit to input)
+//		massGrid	4 2										Optional: rows and columns of mass comparison
+//		chargeGrid	1 2										and charge comparison pictures (MakePlots.C;
+//															default: fit to the number of histograms)
+// A list (charges or masses) may be continued over several lines by repeating its key.
+//**************************************************************************************************************
+
+#ifndef SampleConfig_h
+#define SampleConfig_h
+
+#include <string>
+#include <vector>
+
+struct SampleConfig
+{
+	std::vector<std::string> charges;
+	std::vector<std::string> masses;
+	std::string inputTemplate;
+	std::string sampleTemplate;
+	std::string cacheDir;
+	std::string massPlotTemplate;
+	std::string chargePlotTemplate;
+	int threads;
+	bool bulkRead;
+	int maxParticles;
+	int massGridRows, massGridCols;			// 0: fit to the number of masses
+	int chargeGridRows, chargeGridCols;		// 0: fit to the number of charges
+
+	SampleConfig();
+	bool        Read (const char* path);
+	int         GetNumSamples() const { return charges.size() * masses.size(); }
+	float       GetCharge (int i) const;
+	std::string GetSampleName (int i, int j) const;
+	std::string GetInputPath (int i, int j) const;
+	std::string GetMassPlotName (int i) const;
+	std::string GetChargePlotName (int j) const;
+	std::string Expand (const std::string& text, int i, int j) const;
+};
+
+#endif